@@ -2,75 +2,327 @@
 #define BASELINE
 
 #include "utils.hpp"
-#include <cstring>
+#include <algorithm>
 #include <iostream>
+#include <memory>
+#include <new>
 #include <ostream>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
-template<typename K, typename V>
-struct Slot {
-    uint8_t fingerprint;
-    K key;
-    V value;
-};
-
+// Separate chaining with std::unordered_map semantics: entries never move
+// once inserted, so pointers returned by find() stay valid across inserts and
+// rehashes. Nodes are intrusive singly-linked lists carved out of slabs
+// rather than allocated one by one, and each caches its full hash so chain
+// walks and rehashing never re-hash a key.
 template <typename K, typename V> class LLHashMap {
-    using Entry = Slot<K, V>;
+    struct Node {
+        Node *next;
+        size_t hash;
+        K key;
+        V value;
+    };
+
+    // Hands out nodes from slabs that are only released with the map. Each
+    // new slab is as large as everything allocated before it, so n entries
+    // cost O(log n) allocations.
+    class NodePool {
+        struct Slab {
+            Node *nodes;
+            size_t capacity;
+            size_t used;
+        };
+
+        std::allocator<Node> m_alloc;
+        std::vector<Slab> m_slabs;
+        size_t m_total = 0;
+        // Slab currently handing out nodes; earlier slabs are full.
+        size_t m_current = 0;
+
+        void add_slab(size_t capacity) {
+            m_slabs.push_back({m_alloc.allocate(capacity), capacity, 0});
+            m_total += capacity;
+        }
+
+        void destroy_nodes() {
+            for (Slab &slab : m_slabs) {
+                for (size_t i = 0; i < slab.used; ++i) {
+                    slab.nodes[i].~Node();
+                }
+                slab.used = 0;
+            }
+        }
+
+      public:
+        explicit NodePool(size_t first_slab) {
+            add_slab(std::max<size_t>(first_slab, 16));
+        }
 
-    std::vector<std::vector<Entry>> m_store;
-    size_t m_capacity;
+        NodePool(const NodePool &) = delete;
+        NodePool &operator=(const NodePool &) = delete;
+
+        NodePool(NodePool &&other) noexcept
+            : m_slabs(std::move(other.m_slabs)),
+              m_total(std::exchange(other.m_total, 0)),
+              m_current(std::exchange(other.m_current, 0)) {}
+
+        ~NodePool() {
+            destroy_nodes();
+            for (Slab &slab : m_slabs) {
+                m_alloc.deallocate(slab.nodes, slab.capacity);
+            }
+        }
+
+        void swap(NodePool &other) noexcept {
+            std::swap(m_slabs, other.m_slabs);
+            std::swap(m_total, other.m_total);
+            std::swap(m_current, other.m_current);
+        }
+
+        // Destroys every node but keeps the slabs for reuse.
+        void clear() {
+            destroy_nodes();
+            m_current = 0;
+        }
+
+        // Slab and slab-list bytes; node contents are accounted by the map.
+        size_t memory_usage() const {
+            return m_total * sizeof(Node) + m_slabs.capacity() * sizeof(Slab);
+        }
+
+        // Makes sure n nodes fit without further allocation.
+        void reserve(size_t n) {
+            if (n > m_total) {
+                add_slab(n - m_total);
+            }
+        }
+
+        Node *make(size_t hash, const K &key, V value) {
+            while (m_current < m_slabs.size() &&
+                   m_slabs[m_current].used == m_slabs[m_current].capacity) {
+                m_current += 1;
+            }
+            if (m_current == m_slabs.size()) {
+                add_slab(std::max<size_t>(m_total, 16));
+            }
+            Slab &slab = m_slabs[m_current];
+            // Count the node only once it exists: if copying the key throws,
+            // destroy_nodes() must not run ~Node() on the raw slot.
+            Node *node = new (&slab.nodes[slab.used])
+                Node{nullptr, hash, key, std::move(value)};
+            slab.used += 1;
+            return node;
+        }
+    };
+
+    std::vector<Node *> m_buckets;
+    size_t m_shift;
     size_t m_count;
+    NodePool m_pool;
 
   private:
-    inline size_t hash_key(const K &key) const { return hash_key_fast(key); }
+    inline size_t hash_key(const K &key) const {
+        return KeyTraits<K>::hash_fast(key);
+    }
+
+    // Buckets come from the top bits of the hash: hash_key_fast ends in a
+    // multiply, which mixes the high bits far better than the low ones.
+    inline size_t find_slot(size_t hash) const { return hash >> m_shift; }
 
-    inline size_t find_slot(size_t hash) const {
-        return hash % m_capacity;
+    Node *find_node(const K &key, size_t hash) const {
+        if (m_buckets.empty()) {
+            return nullptr;
+        }
+        for (Node *node = m_buckets[find_slot(hash)]; node != nullptr;
+             node = node->next) {
+            if (node->hash == hash && KeyTraits<K>::equal(node->key, key)) {
+                return node;
+            }
+        }
+        return nullptr;
+    }
+
+    // Replaces the bucket array with `buckets` heads (a power of two) and
+    // relinks every node into it. Nodes stay where they are; only the next
+    // pointers change.
+    void rehash(size_t buckets) {
+        std::vector<Node *> old = std::move(m_buckets);
+        m_buckets.assign(buckets, nullptr);
+        m_shift = 64 - log2(buckets);
+        for (Node *node : old) {
+            while (node != nullptr) {
+                Node *next = node->next;
+                Node *&head = m_buckets[find_slot(node->hash)];
+                node->next = head;
+                head = node;
+                node = next;
+            }
+        }
     }
 
+    static size_t log2(size_t n) { return 63 - __builtin_clzll(n); }
+
   public:
-    LLHashMap(size_t capacity) {
-        m_store = std::vector<std::vector<Entry>>(capacity);
-        m_capacity = capacity;
+    LLHashMap(size_t capacity) : m_pool(capacity) {
+        const size_t buckets = std::max<size_t>(next_power_of_2(capacity), 16);
+        m_buckets.assign(buckets, nullptr);
+        m_shift = 64 - log2(buckets);
         m_count = 0;
     }
 
     LLHashMap() = delete;
     LLHashMap(const LLHashMap &) = delete;
-    LLHashMap(LLHashMap &&) = delete;
     LLHashMap operator=(const LLHashMap &) = delete;
-    LLHashMap operator=(LLHashMap &&) = delete;
+
+    // A moved-from map has no buckets; it stays usable and allocates them
+    // again on the next insert.
+    LLHashMap(LLHashMap &&other) noexcept
+        : m_buckets(std::move(other.m_buckets)), m_shift(other.m_shift),
+          m_count(std::exchange(other.m_count, 0)),
+          m_pool(std::move(other.m_pool)) {}
+
+    LLHashMap &operator=(LLHashMap &&other) noexcept {
+        LLHashMap moved(std::move(other));
+        swap(moved);
+        return *this;
+    }
+
+    void swap(LLHashMap &other) noexcept {
+        std::swap(m_buckets, other.m_buckets);
+        std::swap(m_shift, other.m_shift);
+        std::swap(m_count, other.m_count);
+        m_pool.swap(other.m_pool);
+    }
+
+    // Destroys every entry but keeps the bucket array and node slabs, so
+    // refilling to the same size allocates nothing.
+    void clear() {
+        m_pool.clear();
+        std::fill(m_buckets.begin(), m_buckets.end(), nullptr);
+        m_count = 0;
+    }
+
+    // Sizes the buckets and node slabs so n entries fit without rehashing
+    // or allocating.
+    void reserve(size_t n) {
+        m_pool.reserve(n);
+        const size_t buckets = next_power_of_2(std::max<size_t>(n, 16));
+        if (buckets > m_buckets.size()) {
+            rehash(buckets);
+        }
+    }
 
     void insert(const K &key, V value) {
-        size_t hash = hash_key(key);
-        uint8_t fingerprint = hash & 0xFF;
-        size_t index = find_slot(hash);
-        auto &chain = m_store[index];
-        for (auto &entry : chain) {
-            if (entry.fingerprint == fingerprint && entry.key == key) {
-                entry.value = std::move(value);
-                entry.fingerprint = fingerprint;
-                return;
-            }
+        const size_t hash = hash_key(key);
+        if (Node *node = find_node(key, hash)) {
+            node->value = std::move(value);
+            return;
         }
 
-        chain.push_back({fingerprint, std::move(key), std::move(value)});
+        // Keep the load factor at or below 1, like std::unordered_map.
+        if (m_count >= m_buckets.size()) {
+            rehash(std::max<size_t>(m_buckets.size() * 2, 16));
+        }
+        Node *node = m_pool.make(hash, key, std::move(value));
+        Node *&head = m_buckets[find_slot(hash)];
+        node->next = head;
+        head = node;
         m_count += 1;
     }
 
-    V *get_value(const K &key) const {
-        size_t index = find_slot(key);
-        auto &chain = m_store[index];
-        for (auto &item : chain) {
-            if (item.first == key) {
-                return &item.second;
+    V *find(const K &key) {
+        Node *node = find_node(key, hash_key(key));
+        return node ? &node->value : nullptr;
+    }
+    const V *find(const K &key) const {
+        Node *node = find_node(key, hash_key(key));
+        return node ? &node->value : nullptr;
+    }
+
+    V *get_value(const K &key) { return find(key); }
+    const V *get_value(const K &key) const { return find(key); }
+
+    size_t size() const { return m_count; }
+    size_t bucket_count() const { return m_buckets.size(); }
+
+    // Bytes held by the map: itself, the bucket heads, every node slab
+    // (including unused nodes), and heap bytes owned by live keys.
+    size_t memory_usage() const {
+        size_t bytes = sizeof(*this) + m_buckets.capacity() * sizeof(Node *) +
+                       m_pool.memory_usage();
+        for_each([&](const K &key, const V &) {
+            bytes += KeyTraits<K>::heap_bytes(key);
+        });
+        return bytes;
+    }
+
+    // Walks the chains bucket by bucket, skipping empty buckets.
+    template <typename Value> class Iterator {
+        const std::vector<Node *> *m_buckets;
+        size_t m_bucket;
+        Node *m_node;
+
+        void skip_empty() {
+            while (m_node == nullptr && ++m_bucket < m_buckets->size()) {
+                m_node = (*m_buckets)[m_bucket];
             }
         }
-        return nullptr;
+
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<const K, V>;
+        using reference = std::pair<const K &, Value &>;
+        using difference_type = std::ptrdiff_t;
+
+        struct pointer {
+            reference ref;
+            reference *operator->() { return &ref; }
+        };
+
+        Iterator(const std::vector<Node *> *buckets, size_t bucket)
+            : m_buckets(buckets), m_bucket(bucket), m_node(nullptr) {
+            if (m_bucket < m_buckets->size()) {
+                m_node = (*m_buckets)[m_bucket];
+                skip_empty();
+            }
+        }
+
+        reference operator*() const { return {m_node->key, m_node->value}; }
+        pointer operator->() const { return {**this}; }
+
+        Iterator &operator++() {
+            m_node = m_node->next;
+            skip_empty();
+            return *this;
+        }
+
+        bool operator==(const Iterator &other) const {
+            return m_node == other.m_node;
+        }
+        bool operator!=(const Iterator &other) const {
+            return m_node != other.m_node;
+        }
+    };
+
+    using iterator = Iterator<V>;
+    using const_iterator = Iterator<const V>;
+
+    iterator begin() { return iterator(&m_buckets, 0); }
+    iterator end() { return iterator(&m_buckets, m_buckets.size()); }
+    const_iterator begin() const { return const_iterator(&m_buckets, 0); }
+    const_iterator end() const {
+        return const_iterator(&m_buckets, m_buckets.size());
     }
 
-    size_t size() const { return m_count; }
+    // Calls fn(key, value) for every entry, bucket by bucket.
+    template <typename F> void for_each(F &&fn) const {
+        for (const Node *head : m_buckets) {
+            for (const Node *node = head; node != nullptr; node = node->next) {
+                fn(node->key, node->value);
+            }
+        }
+    }
 
     void print_stats() const {
         size_t zero_count = 0;
@@ -78,8 +330,11 @@ template <typename K, typename V> class LLHashMap {
         size_t sum = 0;
         size_t count = 0;
         std::unordered_map<size_t, size_t> counts;
-        for (const auto &chain : m_store) {
-            size_t length = distance(chain.begin(), chain.end());
+        for (const Node *head : m_buckets) {
+            size_t length = 0;
+            for (const Node *node = head; node != nullptr; node = node->next) {
+                length += 1;
+            }
 
             longest = std::max(longest, length);
             sum += length;
@@ -94,7 +349,7 @@ template <typename K, typename V> class LLHashMap {
         std::cout << "Zero-length buckets: " << zero_count << std::endl;
         std::cout << "Longest-length: " << longest << std::endl;
         std::cout << "Average-length(occupied): " << (sum / count) << std::endl;
-        std::cout << "Average-length(overall): " << (sum / m_store.size())
+        std::cout << "Average-length(overall): " << (sum / m_buckets.size())
                   << std::endl;
 
         for (const auto &[size, count] : counts) {
@@ -1,20 +1,90 @@
 #include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <cstdlib>
 #include <fstream>
+#include <functional>
+#include <new>
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <fcntl.h>
+#include <malloc.h>
+#include <unistd.h>
 
 #include "soaprobe.hpp"
 #include "fpprobe.hpp"
 #include "swiss.hpp"
 #include "baseline.hpp"
 #include "linprobehm.hpp"
+#include "interner.hpp"
+#include "report.hpp"
 
 #define PREALLOC_SLOTS 10'000
 
 using u64 = uint64_t;
 
+// Every heap allocation made by the process, so benchmarks can report how
+// many allocations and bytes a map needed next to its time.
+static size_t g_alloc_count = 0;
+static size_t g_alloc_bytes = 0;
+
+void *operator new(size_t size) {
+    g_alloc_count += 1;
+    g_alloc_bytes += size;
+    if (void *p = std::malloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+// Kept out of line: once inlined, GCC sees free() paired with ::operator new
+// and raises -Wmismatched-new-delete at every delete.
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+    std::free(p);
+}
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept {
+    std::free(p);
+}
+
+// Median absolute deviation, reported next to Google Benchmark's built-in
+// mean/median/stddev when a benchmark is repeated, for reading a single run.
+// tools/compare_bench.py ignores these aggregate rows and computes its own
+// MAD from the per-repetition rows.
+double MedianAbsDeviation(const std::vector<double> &values) {
+    auto median = [](std::vector<double> v) {
+        std::sort(v.begin(), v.end());
+        const size_t mid = v.size() / 2;
+        return v.size() % 2 ? v[mid] : (v[mid - 1] + v[mid]) / 2;
+    };
+    if (values.empty()) {
+        return 0;
+    }
+    const double center = median(values);
+    std::vector<double> deviations;
+    for (double value : values) {
+        deviations.push_back(std::abs(value - center));
+    }
+    return median(deviations);
+}
+
+// RegisterBenchmark plus the MAD statistic; every benchmark goes through it.
+template <typename... Args>
+benchmark::internal::Benchmark *Register(const std::string &name,
+                                         Args &&...args) {
+    return benchmark::RegisterBenchmark(name.c_str(),
+                                        std::forward<Args>(args)...)
+        ->ComputeStatistics("mad", MedianAbsDeviation);
+}
+
+// Records the allocations made since `before_*` as benchmark counters.
+void ReportAllocs(benchmark::State &state, size_t before_count,
+                  size_t before_bytes) {
+    state.counters["allocs"] = g_alloc_count - before_count;
+    state.counters["alloc_bytes"] = g_alloc_bytes - before_bytes;
+}
+
 std::vector<std::string> lines;
 void LoadLines(size_t ROWS_TO_READ = 1'000'000) {
     std::ifstream file("/home/sbhusal/hashmap/measurements.txt");
@@ -29,7 +99,24 @@ void LoadLines(size_t ROWS_TO_READ = 1'000'000) {
     std::cout << "Read " << lines.size() << " lines into the buffer\n";
 }
 
+// Integer-keyed copies of the workload: each distinct city gets a random
+// 64-bit ID, so the key stream has the same repetition pattern as `lines`.
+std::vector<u64> ids64;
+std::vector<uint32_t> ids32;
+void LoadIds() {
+    std::unordered_map<std::string, u64> assigned;
+    for (const auto &city : lines) {
+        auto [it, inserted] = assigned.try_emplace(city, 0);
+        if (inserted) {
+            it->second = mix_u64(assigned.size());
+        }
+        ids64.push_back(it->second);
+        ids32.push_back(static_cast<uint32_t>(it->second));
+    }
+}
+
 void test_stdmap(benchmark::State &state) {
+    const size_t allocs = g_alloc_count, bytes = g_alloc_bytes;
     std::unordered_map<std::string, uint64_t> map(PREALLOC_SLOTS);
     for (auto _ : state) {
         int off = 0;
@@ -43,9 +130,11 @@ void test_stdmap(benchmark::State &state) {
     }
 
     benchmark::DoNotOptimize(map);
+    ReportAllocs(state, allocs, bytes);
 }
 
 void test_baseline(benchmark::State &state) {
+    const size_t allocs = g_alloc_count, bytes = g_alloc_bytes;
     LLHashMap<std::string, uint64_t> map(PREALLOC_SLOTS);
     for (auto _ : state) {
         int off = 0;
@@ -56,6 +145,7 @@ void test_baseline(benchmark::State &state) {
     }
 
     benchmark::DoNotOptimize(map);
+    ReportAllocs(state, allocs, bytes);
 }
 
 void test_linprobe(benchmark::State &state) {
@@ -110,18 +200,447 @@ void test_soaprobe(benchmark::State &state) {
     benchmark::DoNotOptimize(map);
 }
 
+// Same workload through an Interner: each city becomes a dense id, and the
+// per-city value lives in a plain vector indexed by that id.
+void test_interner(benchmark::State &state) {
+    Interner interner(PREALLOC_SLOTS);
+    std::vector<uint64_t> values;
+    for (auto _ : state) {
+        int off = 0;
+        for (const auto &city : lines) {
+            off += 1;
+            const uint32_t id = interner.intern(city);
+            if (id >= values.size()) {
+                values.resize(id + 1);
+            }
+            values[id] = off;
+        }
+    }
+
+    benchmark::DoNotOptimize(values.data());
+}
+
+void test_interner_batch(benchmark::State &state) {
+    Interner interner(PREALLOC_SLOTS);
+    std::vector<uint64_t> values;
+    std::vector<uint32_t> ids(lines.size());
+    for (auto _ : state) {
+        interner.intern(lines.begin(), lines.end(), ids.data());
+        values.resize(interner.size());
+        int off = 0;
+        for (const uint32_t id : ids) {
+            off += 1;
+            values[id] = off;
+        }
+    }
+
+    benchmark::DoNotOptimize(values.data());
+}
+
+// `count` distinct pseudo-random station names, 4 to 23 letters long, so
+// roughly a third are too long for std::string's small-string buffer.
+std::vector<std::string> MakeNames(size_t count) {
+    u64 seed = 0x9E3779B97F4A7C15ULL;
+    auto next = [&seed] {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        return seed;
+    };
+    // Duplicates are tracked in a flat table of views into `names`, which is
+    // reserved so the views stay valid. A node-based set would leave small
+    // holes between the name buffers once freed; later maps would reuse
+    // them, and TestMemory's RSS deltas would miss those bytes.
+    std::vector<std::string> names;
+    names.reserve(count);
+    SwissHashMap<std::string_view, bool> seen(count);
+    while (names.size() < count) {
+        std::string name(4 + next() % 20, ' ');
+        for (char &c : name) {
+            c = 'a' + next() % 26;
+        }
+        name[0] = 'A' + name[0] - 'a';
+        if (!seen.find(name)) {
+            names.push_back(std::move(name));
+            seen.insert(names.back(), true);
+        }
+    }
+    return names;
+}
+
+// Resident set size of the process right now, from /proc/self/statm. Read
+// into a stack buffer so the probe itself allocates nothing; a stream would
+// show up in g_alloc_bytes and in the RSS it is measuring.
+long CurrentRssKiB() {
+    char buffer[128];
+    const int fd = open("/proc/self/statm", O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+    const ssize_t length = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+    if (length <= 0) {
+        return 0;
+    }
+    buffer[length] = '\0';
+    char *resident = nullptr;
+    std::strtol(buffer, &resident, 10); // total program size, unused
+    return std::strtol(resident, nullptr, 10) * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// Resident memory a build adds, measured around `build`. Free heap pages are
+// handed back to the kernel first, so the build's allocations fault in new
+// pages instead of silently reusing ones left over from earlier benchmarks.
+// The measurement itself is excluded from the timing.
+template <typename F> long RssDeltaKiB(benchmark::State &state, F &&build) {
+    state.PauseTiming();
+    malloc_trim(0);
+    const long before = CurrentRssKiB();
+    state.ResumeTiming();
+    build();
+    state.PauseTiming();
+    const long delta = CurrentRssKiB() - before;
+    state.ResumeTiming();
+    return delta;
+}
+
+// Entries per slot, or per bucket for the chained map.
+template <typename Map> double LoadFactor(const Map &map) {
+    return static_cast<double>(map.size()) / map.slot_count();
+}
+template <typename K, typename V>
+double LoadFactor(const LLHashMap<K, V> &map) {
+    return static_cast<double>(map.size()) / map.bucket_count();
+}
+
+// Memory footprint of a map sized for PREALLOC_SLOTS entries and filled with
+// `percent`% of that many distinct keys; the percentage is of the requested
+// capacity, not a load factor, which the load_factor counter reports.
+// bytes_per_entry divides everything the map holds (see memory_usage()) by
+// the live entries. rss_kib is the resident memory the map's construction
+// and fill added, measured for this configuration alone.
+template <typename Map>
+void test_memory(benchmark::State &state, size_t percent) {
+    const std::vector<std::string> names =
+        MakeNames(PREALLOC_SLOTS * percent / 100);
+    size_t bytes = 0;
+    long rss_kib = 0;
+    double load_factor = 0;
+    for (auto _ : state) {
+        std::optional<Map> map;
+        rss_kib = RssDeltaKiB(state, [&] {
+            map.emplace(PREALLOC_SLOTS);
+            for (size_t i = 0; i < names.size(); ++i) {
+                map->insert(names[i], i);
+            }
+        });
+        bytes = map->memory_usage();
+        load_factor = LoadFactor(*map);
+        benchmark::DoNotOptimize(map);
+    }
+    state.counters["bytes"] = bytes;
+    state.counters["bytes_per_entry"] =
+        static_cast<double>(bytes) / names.size();
+    state.counters["rss_kib"] = rss_kib;
+    state.counters["load_factor"] = load_factor;
+}
+
+// std::unordered_map has no memory_usage(), so its footprint is what it
+// allocated while being built.
+void test_memory_stdmap(benchmark::State &state, size_t percent) {
+    const std::vector<std::string> names =
+        MakeNames(PREALLOC_SLOTS * percent / 100);
+    size_t bytes = 0;
+    long rss_kib = 0;
+    double load_factor = 0;
+    for (auto _ : state) {
+        const size_t before = g_alloc_bytes;
+        std::optional<std::unordered_map<std::string, u64>> map;
+        rss_kib = RssDeltaKiB(state, [&] {
+            map.emplace(PREALLOC_SLOTS);
+            for (size_t i = 0; i < names.size(); ++i) {
+                map->try_emplace(names[i], i);
+            }
+        });
+        bytes = sizeof(*map) + g_alloc_bytes - before;
+        load_factor = map->load_factor();
+        benchmark::DoNotOptimize(map);
+    }
+    state.counters["bytes"] = bytes;
+    state.counters["bytes_per_entry"] =
+        static_cast<double>(bytes) / names.size();
+    state.counters["rss_kib"] = rss_kib;
+    state.counters["load_factor"] = load_factor;
+}
+
+void RegisterMemoryBenchmarks() {
+    for (size_t percent : {25, 50, 75, 100}) {
+        const std::string suffix = "/" + std::to_string(percent);
+        Register("TestMemory/StdMap" + suffix, test_memory_stdmap, percent);
+        Register("TestMemory/Baseline" + suffix,
+                 test_memory<LLHashMap<std::string, u64>>, percent);
+        Register("TestMemory/LinearProbing" + suffix,
+                 test_memory<LinProbeHashMap<std::string, u64>>, percent);
+        Register("TestMemory/FPProbe" + suffix,
+                 test_memory<FPProbeHashMap<std::string, u64>>, percent);
+        Register("TestMemory/SoAProbe" + suffix,
+                 test_memory<SoAProbeHashMap<std::string, u64>>, percent);
+        Register("TestMemory/Swiss" + suffix,
+                 test_memory<SwissHashMap<std::string, u64>>, percent);
+    }
+}
+
+// Windowed aggregation: fill a map from WINDOW_ROWS rows, emit it, start over.
+// The two variants differ only in how the map is reset between windows.
+#define WINDOW_ROWS 5'000
+
+template <typename Map> u64 AggregateWindow(Map &map, size_t start) {
+    const size_t stop = std::min(start + WINDOW_ROWS, lines.size());
+    for (size_t i = start; i < stop; ++i) {
+        map.insert(lines[i], i);
+    }
+    u64 emitted = 0;
+    map.for_each([&](const std::string &, u64 value) { emitted += value; });
+    return emitted;
+}
+
+void test_window_fresh(benchmark::State &state) {
+    for (auto _ : state) {
+        u64 emitted = 0;
+        for (size_t start = 0; start < lines.size(); start += WINDOW_ROWS) {
+            SwissHashMap<std::string, u64> map(PREALLOC_SLOTS);
+            emitted += AggregateWindow(map, start);
+        }
+        benchmark::DoNotOptimize(emitted);
+    }
+}
+
+void test_window_clear(benchmark::State &state) {
+    SwissHashMap<std::string, u64> map(PREALLOC_SLOTS);
+    for (auto _ : state) {
+        u64 emitted = 0;
+        for (size_t start = 0; start < lines.size(); start += WINDOW_ROWS) {
+            map.clear();
+            emitted += AggregateWindow(map, start);
+        }
+        benchmark::DoNotOptimize(emitted);
+    }
+}
+
+template <typename Map, typename Key>
+void test_int_keys(benchmark::State &state, const std::vector<Key> &keys) {
+    Map map(PREALLOC_SLOTS);
+    for (auto _ : state) {
+        int off = 0;
+        for (const Key key : keys) {
+            off += 1;
+            map.insert(key, off);
+        }
+    }
+
+    benchmark::DoNotOptimize(map);
+}
+
+void test_stdmap_int(benchmark::State &state, const std::vector<u64> &keys) {
+    std::unordered_map<u64, uint64_t> map(PREALLOC_SLOTS);
+    for (auto _ : state) {
+        int off = 0;
+        for (const u64 key : keys) {
+            off += 1;
+            map.insert_or_assign(key, off);
+        }
+    }
+
+    benchmark::DoNotOptimize(map);
+}
+
+// RegisterBenchmark copies its extra arguments into each benchmark, so the
+// key vectors are passed by std::cref to share the one global copy.
+template <typename Key>
+void RegisterIntBenchmarks(const char *suffix, const std::vector<Key> &keys) {
+    auto name = [suffix](const char *map) { return std::string(map) + suffix; };
+    Register(name("TestBaseline"),
+             test_int_keys<LLHashMap<Key, uint64_t>, Key>, std::cref(keys));
+    Register(name("TestLinearProbing"),
+             test_int_keys<LinProbeHashMap<Key, uint64_t>, Key>,
+             std::cref(keys));
+    Register(name("TestFPProbe"),
+             test_int_keys<FPProbeHashMap<Key, uint64_t>, Key>,
+             std::cref(keys));
+    Register(name("TestSoAProbe"),
+             test_int_keys<SoAProbeHashMap<Key, uint64_t>, Key>,
+             std::cref(keys));
+    Register(name("TestSwiss"),
+             test_int_keys<SwissHashMap<Key, uint64_t>, Key>, std::cref(keys));
+}
+
+template <typename Map> void test_combo(benchmark::State &state) {
+    Map map(PREALLOC_SLOTS);
+    for (auto _ : state) {
+        int off = 0;
+        for (const auto &city : lines) {
+            off += 1;
+            map.insert(city, off);
+        }
+    }
+
+    benchmark::DoNotOptimize(map);
+}
+
+template <typename Layout, typename Metadata, typename Probe, typename Match>
+void RegisterCombo() {
+    using Table =
+        HashTable<std::string, uint64_t, Layout, Metadata, Probe, Match>;
+    std::string name = std::string("TestCombo/") + Layout::kName + "/" +
+                       Metadata::kName + "/" + Probe::kName + "/" +
+                       Match::kName;
+    Register(name, test_combo<Table>);
+}
+
+// Registers every metadata and probe choice for one layout and match kernel,
+// so configurations outside the named aliases can be compared.
+template <typename Layout, typename Match> void RegisterCombos() {
+    RegisterCombo<Layout, NoMetadata, LinearProbe, Match>();
+    RegisterCombo<Layout, NoMetadata, QuadraticProbe, Match>();
+    RegisterCombo<Layout, Fingerprint8, LinearProbe, Match>();
+    RegisterCombo<Layout, Fingerprint8, QuadraticProbe, Match>();
+    RegisterCombo<Layout, H2Metadata, LinearProbe, Match>();
+    RegisterCombo<Layout, H2Metadata, QuadraticProbe, Match>();
+}
+
+// Lookups that mostly miss, as when probing a table with keys it mostly
+// lacks (joins, dedup against a small set). The map holds `entries` names;
+// of MISS_QUERIES lookups, one in ten asks for one of them and the rest ask
+// for names that were never inserted.
+#define MISS_QUERIES 100'000
+
+template <typename Map>
+void test_miss_lookups(benchmark::State &state, size_t entries) {
+    const std::vector<std::string> names = MakeNames(entries + MISS_QUERIES);
+    Map map(entries);
+    for (size_t i = 0; i < entries; ++i) {
+        map.insert(names[i], i);
+    }
+    std::vector<std::string> queries;
+    queries.reserve(MISS_QUERIES);
+    for (size_t i = 0; i < MISS_QUERIES; ++i) {
+        queries.push_back(i % 10 == 0 ? names[i % entries]
+                                      : names[entries + i]);
+    }
+
+    size_t hits = 0;
+    for (auto _ : state) {
+        hits = 0;
+        for (const std::string &query : queries) {
+            hits += map.find(query) != nullptr;
+        }
+        benchmark::DoNotOptimize(hits);
+    }
+    state.counters["hit_rate"] = static_cast<double>(hits) / queries.size();
+    state.counters["bytes"] = map.memory_usage();
+}
+
+// FPProbe with and without the Bloom prefilter, next to Swiss, whose control
+// bytes already reject most misses without touching the entries.
+void RegisterMissBenchmarks() {
+    for (size_t entries : {1'000, 64'000, 1'000'000}) {
+        const std::string suffix = "/" + std::to_string(entries);
+        Register("TestMissLookup/Swiss" + suffix,
+                 test_miss_lookups<SwissHashMap<std::string, u64>>, entries);
+        Register("TestMissLookup/FPProbe" + suffix,
+                 test_miss_lookups<FPProbeHashMap<std::string, u64>>, entries);
+        Register("TestMissLookup/FPProbeBloom" + suffix,
+                 test_miss_lookups<FilteredFPProbeHashMap<std::string, u64>>,
+                 entries);
+    }
+}
+
+// Output stage only: the map already holds one CityStats per station, and we
+// time producing the sorted "{city=min/mean/max, ...}" report from it.
+void test_report(benchmark::State &state) {
+    SwissHashMap<std::string, CityStats> map(PREALLOC_SLOTS);
+    int32_t tenths = 0;
+    for (const std::string &name : MakeNames(PREALLOC_SLOTS)) {
+        tenths = (tenths * 7919 + 17) % 1999;
+        CityStats stats;
+        stats.add(tenths - 999);
+        stats.add(999 - tenths);
+        map.insert(name, stats);
+    }
+    for (auto _ : state) {
+        std::string report = format_report(map);
+        benchmark::DoNotOptimize(report.data());
+    }
+}
+
+// Dataset and build parameters recorded in the JSON "context" block, next to
+// the CPU and cache details Google Benchmark collects itself.
+void AddRunContext() {
+    std::unordered_set<u64> distinct(ids64.begin(), ids64.end());
+    benchmark::AddCustomContext("dataset_rows", std::to_string(lines.size()));
+    benchmark::AddCustomContext("distinct_cities",
+                                std::to_string(distinct.size()));
+    benchmark::AddCustomContext("prealloc_slots",
+                                std::to_string(PREALLOC_SLOTS));
+    benchmark::AddCustomContext("window_rows", std::to_string(WINDOW_ROWS));
+    benchmark::AddCustomContext("compiler", __VERSION__);
+
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.rfind("model name", 0) == 0) {
+            benchmark::AddCustomContext(
+                "cpu_model", line.substr(line.find(':') + 2));
+            break;
+        }
+    }
+}
+
+// Usage: bench [rows] [benchmark flags]
+// Unless --benchmark_out is given, results are also written as JSON to
+// bench.json. Compare two runs with tools/compare_bench.py; run with
+// --benchmark_repetitions=N so it has samples to test.
 int main(int argc, char **argv) {
     if (argc > 1) {
         LoadLines(atoi(argv[1]));
     }
+    LoadIds();
+
+    std::vector<char *> args(argv, argv + argc);
+    bool has_out = false;
+    for (char *arg : args) {
+        has_out |= std::string(arg).rfind("--benchmark_out=", 0) == 0;
+    }
+    std::string out_flag = "--benchmark_out=bench.json";
+    std::string format_flag = "--benchmark_out_format=json";
+    if (!has_out) {
+        args.push_back(out_flag.data());
+        args.push_back(format_flag.data());
+    }
+    int args_count = static_cast<int>(args.size());
 
-    benchmark::Initialize(&argc, argv);
-    benchmark::RegisterBenchmark("TestStdMap", test_stdmap);
-    benchmark::RegisterBenchmark("TestBaseline", test_baseline);
-    benchmark::RegisterBenchmark("TestLinearProbing", test_linprobe);
-    benchmark::RegisterBenchmark("TestFPProbe", test_fpprobe);
-    benchmark::RegisterBenchmark("TestSoAProbe", test_soaprobe);
-    benchmark::RegisterBenchmark("TestSwiss", test_swiss);
+    benchmark::Initialize(&args_count, args.data());
+    AddRunContext();
+    Register("TestStdMap", test_stdmap);
+    Register("TestBaseline", test_baseline);
+    Register("TestLinearProbing", test_linprobe);
+    Register("TestFPProbe", test_fpprobe);
+    Register("TestSoAProbe", test_soaprobe);
+    Register("TestSwiss", test_swiss);
+    Register("TestInterner", test_interner);
+    Register("TestInternerBatch", test_interner_batch);
+    Register("TestStdMap/u64", test_stdmap_int, std::cref(ids64));
+    RegisterIntBenchmarks("/u64", ids64);
+    RegisterIntBenchmarks("/u32", ids32);
+    Register("TestWindowFresh", test_window_fresh);
+    Register("TestWindowClear", test_window_clear);
+    RegisterMemoryBenchmarks();
+    RegisterMissBenchmarks();
+    RegisterCombos<AoS, ScalarMatch>();
+    RegisterCombos<AoS, Sse2Match>();
+    RegisterCombos<SoA, ScalarMatch>();
+    RegisterCombos<SoA, Sse2Match>();
+    Register("TestReport", test_report);
     benchmark::RunSpecifiedBenchmarks();
     return 0;
 }
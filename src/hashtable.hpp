@@ -0,0 +1,652 @@
+#ifndef HASHTABLE_HPP
+#define HASHTABLE_HPP
+
+#include "utils.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <ratio>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <emmintrin.h> // SSE2
+
+// One open-addressing table, assembled from policies:
+//
+//   Layout    where keys and values live (AoS entries, SoA arrays, or
+//             entries that carry their own control byte)
+//   Metadata  what the per-slot control byte holds (nothing, fp8, h2)
+//   Probe     which group of slots to look at next (linear, quadratic)
+//   Match     how a group of control bytes is compared (scalar, SSE2)
+//   Hash      which KeyTraits hash to use (fast, strong)
+//   Sizing    slots per requested entry, as a std::ratio
+//   Prefilter membership filter consulted before probing (none, bloom.hpp)
+//
+// With AoS and SoA, control bytes live in their own array, padded by one
+// group whose bytes mirror the first group, so a group load at any slot
+// index is in bounds and sees the slots it wraps around to. Probing is then
+// group at a time: a group starting at pos covers pos..pos+15, which for
+// linear probing is exactly the slot-by-slot order. InlineTag keeps the byte
+// in the entry instead and probes linearly one slot at a time.
+//
+// Tables do not grow on their own and have no erase; insert throws once
+// every slot is full, and reserve() is the way to make room. The metadata
+// tag comes from the top bits of the hash and the slot position from the
+// low bits, so the two are independent.
+
+constexpr size_t kGroupWidth = 16;
+
+// --- Layouts ---
+
+struct AoS {
+    static constexpr const char *kName = "AoS";
+    static constexpr bool kInlineTag = false;
+
+    template <typename K, typename V> class Storage {
+        struct Entry {
+            K key;
+            V value;
+        };
+        std::vector<Entry> m_entries;
+
+      public:
+        explicit Storage(size_t slots) : m_entries(slots) {}
+
+        K &key(size_t index) { return m_entries[index].key; }
+        const K &key(size_t index) const { return m_entries[index].key; }
+        V &value(size_t index) { return m_entries[index].value; }
+        const V &value(size_t index) const { return m_entries[index].value; }
+
+        void prefetch(size_t index) const {
+            __builtin_prefetch(&m_entries[index]);
+        }
+
+        size_t memory_usage() const {
+            return m_entries.capacity() * sizeof(Entry);
+        }
+    };
+};
+
+struct SoA {
+    static constexpr const char *kName = "SoA";
+    static constexpr bool kInlineTag = false;
+
+    template <typename K, typename V> class Storage {
+        std::vector<K> m_keys;
+        std::vector<V> m_values;
+
+      public:
+        explicit Storage(size_t slots) : m_keys(slots), m_values(slots) {}
+
+        K &key(size_t index) { return m_keys[index]; }
+        const K &key(size_t index) const { return m_keys[index]; }
+        V &value(size_t index) { return m_values[index]; }
+        const V &value(size_t index) const { return m_values[index]; }
+
+        void prefetch(size_t index) const {
+            __builtin_prefetch(&m_keys[index]);
+        }
+
+        size_t memory_usage() const {
+            return m_keys.capacity() * sizeof(K) +
+                   m_values.capacity() * sizeof(V);
+        }
+    };
+};
+
+// Entries of tag, key and value, like the original LinProbe/FPProbe maps: a
+// probe touches one entry, not a control byte and then an entry elsewhere.
+// There is no control array, so only slot-at-a-time linear probing applies.
+struct InlineTag {
+    static constexpr const char *kName = "Inline";
+    static constexpr bool kInlineTag = true;
+
+    template <typename K, typename V> class Storage {
+        struct Entry {
+            int8_t tag;
+            K key;
+            V value;
+        };
+        std::vector<Entry> m_entries;
+
+      public:
+        explicit Storage(size_t slots) : m_entries(slots) {}
+
+        int8_t tag(size_t index) const { return m_entries[index].tag; }
+        void set_tag(size_t index, int8_t tag) { m_entries[index].tag = tag; }
+        void reset_tags(int8_t empty) {
+            for (Entry &entry : m_entries) {
+                entry.tag = empty;
+            }
+        }
+
+        K &key(size_t index) { return m_entries[index].key; }
+        const K &key(size_t index) const { return m_entries[index].key; }
+        V &value(size_t index) { return m_entries[index].value; }
+        const V &value(size_t index) const { return m_entries[index].value; }
+
+        void prefetch(size_t index) const {
+            __builtin_prefetch(&m_entries[index]);
+        }
+
+        size_t memory_usage() const {
+            return m_entries.capacity() * sizeof(Entry);
+        }
+    };
+};
+
+// --- Metadata schemes ---
+// Each maps a hash to the control byte stored for a full slot and reserves
+// kEmpty, which no full slot may use.
+
+// No hash bits: the byte only marks the slot full, so every full slot on the
+// probe path costs a key compare.
+struct NoMetadata {
+    static constexpr const char *kName = "NoMeta";
+    static constexpr int8_t kEmpty = 0;
+    static int8_t tag(size_t) { return 1; }
+};
+
+// 8-bit fingerprint from the top byte of the hash; 0 is folded into 1.
+struct Fingerprint8 {
+    static constexpr const char *kName = "FP8";
+    static constexpr int8_t kEmpty = 0;
+    static int8_t tag(size_t hash) {
+        const uint8_t fp = static_cast<uint8_t>(hash >> 56);
+        return static_cast<int8_t>(fp | (fp == 0));
+    }
+};
+
+// Swiss-table style: 7 bits of hash with the MSB clear; empty is 0x80.
+struct H2Metadata {
+    static constexpr const char *kName = "H2";
+    static constexpr int8_t kEmpty = static_cast<int8_t>(0x80);
+    static int8_t tag(size_t hash) { return static_cast<int8_t>(hash >> 57); }
+};
+
+// --- Probe sequences ---
+// Both visit every group-width window of a power-of-two table within
+// capacity / kGroupWidth steps.
+
+struct LinearProbe {
+    static constexpr const char *kName = "Linear";
+    size_t pos;
+
+    LinearProbe(size_t hash, size_t mask) : pos(hash & mask) {}
+    void next(size_t mask) { pos = (pos + kGroupWidth) & mask; }
+};
+
+// Triangular steps of whole groups, as in SwissTable.
+struct QuadraticProbe {
+    static constexpr const char *kName = "Quadratic";
+    size_t pos;
+    size_t step = 0;
+
+    QuadraticProbe(size_t hash, size_t mask) : pos(hash & mask) {}
+    void next(size_t mask) {
+        step += kGroupWidth;
+        pos = (pos + step) & mask;
+    }
+};
+
+// --- Group match kernels ---
+// Bit i of the result is set when group[i] == byte.
+
+// Portable SWAR version: each half of the group is one 64-bit word. Bytes
+// equal to `byte` become zero after the xor, and the exact zero-byte test
+// below turns them into 0x80 with no false positives. The eight high bits
+// are then gathered into one byte with a multiply.
+struct ScalarMatch {
+    static constexpr const char *kName = "Scalar";
+
+    static inline uint32_t match_word(uint64_t word, uint64_t pattern) {
+        constexpr uint64_t kLow7 = 0x7F7F7F7F7F7F7F7FULL;
+        const uint64_t x = word ^ pattern;
+        const uint64_t zeros = ~(((x & kLow7) + kLow7) | x | kLow7);
+        return static_cast<uint32_t>(((zeros >> 7) * 0x0102040810204080ULL) >>
+                                     56);
+    }
+
+    static uint32_t match(const int8_t *group, int8_t byte) {
+        const uint64_t pattern =
+            0x0101010101010101ULL * static_cast<uint8_t>(byte);
+        uint64_t lo, hi;
+        std::memcpy(&lo, group, sizeof(lo));
+        std::memcpy(&hi, group + 8, sizeof(hi));
+        return match_word(lo, pattern) | (match_word(hi, pattern) << 8);
+    }
+};
+
+struct Sse2Match {
+    static constexpr const char *kName = "SSE2";
+    static uint32_t match(const int8_t *group, int8_t byte) {
+        __m128i ctrl =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+        return static_cast<uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(byte))));
+    }
+};
+
+// --- Hashes ---
+
+// Probes take their start from the low bits of the hash. hash_key_fast ends
+// in a multiply, so its low bits only see the last few bytes of the key;
+// folding the high half down mixes the whole key in. The top bits, which
+// feed the tags, are unchanged.
+struct FastHash {
+    template <typename K> static size_t hash(const K &key) {
+        const size_t h = KeyTraits<K>::hash_fast(key);
+        return h ^ (h >> 32);
+    }
+};
+
+struct StrongHash {
+    template <typename K> static size_t hash(const K &key) {
+        return KeyTraits<K>::hash_strong(key);
+    }
+};
+
+// --- Prefilters ---
+// Asked before a lookup probes the table; a false from may_contain() must
+// mean the key was never added. Built for the table's entry capacity and
+// rebuilt when it rehashes.
+
+struct NoPrefilter {
+    static constexpr const char *kName = "NoFilter";
+    explicit NoPrefilter(size_t) {}
+    void add(size_t) {}
+    bool may_contain(size_t) const { return true; }
+    void clear() {}
+    size_t memory_usage() const { return 0; }
+};
+
+template <typename K, typename V, typename Layout, typename Metadata,
+          typename Probe, typename Match, typename Hash = FastHash,
+          typename Sizing = std::ratio<2>, typename Prefilter = NoPrefilter>
+class HashTable {
+    using Storage = typename Layout::template Storage<K, V>;
+    static constexpr bool kInlineTag = Layout::kInlineTag;
+    static_assert(!kInlineTag || (std::is_same_v<Probe, LinearProbe> &&
+                                  std::is_same_v<Match, ScalarMatch>),
+                  "InlineTag probes one slot at a time: use LinearProbe and "
+                  "ScalarMatch");
+
+    size_t m_capacity;
+    size_t m_count;
+    std::vector<int8_t> m_ctrl;
+    Storage m_slots;
+    Prefilter m_filter;
+
+    // Bytes of separate control array for a table of `slots` slots.
+    static size_t ctrl_bytes(size_t slots) {
+        return kInlineTag ? 0 : slots + kGroupWidth;
+    }
+
+    static size_t slots_for(size_t capacity) {
+        return std::max(
+            next_power_of_2(capacity * Sizing::num / Sizing::den),
+            kGroupWidth);
+    }
+
+    // Sets a control byte, keeping the mirrored tail in sync.
+    inline void set_ctrl(size_t index, int8_t value) {
+        if constexpr (kInlineTag) {
+            m_slots.set_tag(index, value);
+        } else {
+            m_ctrl[index] = value;
+            if (index < kGroupWidth) {
+                m_ctrl[m_capacity + index] = value;
+            }
+        }
+    }
+
+    inline bool is_full(size_t index) const {
+        if constexpr (kInlineTag) {
+            return m_slots.tag(index) != Metadata::kEmpty;
+        } else {
+            return m_ctrl[index] != Metadata::kEmpty;
+        }
+    }
+
+    // InlineTag probe: the slot holding key or, failing that, the first
+    // empty slot on its path; m_capacity if every slot is full and none
+    // matches.
+    size_t probe_slots(const K &key, size_t key_hash) const {
+        const int8_t tag = Metadata::tag(key_hash);
+        const size_t mask = m_capacity - 1;
+        size_t index = key_hash & mask;
+        for (size_t n = 0; n < m_capacity; ++n) {
+            const int8_t slot_tag = m_slots.tag(index);
+            if (slot_tag == Metadata::kEmpty ||
+                (slot_tag == tag &&
+                 KeyTraits<K>::equal(m_slots.key(index), key))) {
+                return index;
+            }
+            index = (index + 1) & mask;
+        }
+        return m_capacity;
+    }
+
+    inline uint32_t full_mask(size_t index) const {
+        return ~Match::match(&m_ctrl[index], Metadata::kEmpty) & 0xFFFF;
+    }
+
+    // Tag matches in a group that could hold the key. Nothing is ever erased,
+    // so a key cannot sit past the first empty slot of its probe sequence.
+    static inline uint32_t candidates(uint32_t matches, uint32_t empties) {
+        return empties ? matches & ((empties & -empties) - 1) : matches;
+    }
+
+    // Places a key known to be absent in the first empty slot of its probe
+    // sequence. Used when rehashing, where no key can match.
+    void insert_unique(K &&key, V &&value) {
+        const size_t key_hash = hash(key);
+        size_t index;
+        if constexpr (kInlineTag) {
+            index = probe_slots(key, key_hash);
+        } else {
+            const size_t mask = m_capacity - 1;
+            Probe probe(key_hash, mask);
+            uint32_t empties =
+                Match::match(&m_ctrl[probe.pos], Metadata::kEmpty);
+            while (empties == 0) {
+                probe.next(mask);
+                empties = Match::match(&m_ctrl[probe.pos], Metadata::kEmpty);
+            }
+            index = (probe.pos + __builtin_ctz(empties)) & mask;
+        }
+        set_ctrl(index, Metadata::tag(key_hash));
+        m_slots.key(index) = std::move(key);
+        m_slots.value(index) = std::move(value);
+        m_filter.add(key_hash);
+        m_count++;
+    }
+
+    // Moves every entry into freshly allocated arrays of `slots` slots.
+    void rehash(size_t slots) {
+        std::vector<int8_t> old_ctrl = std::exchange(
+            m_ctrl, std::vector<int8_t>(ctrl_bytes(slots), Metadata::kEmpty));
+        Storage old_slots = std::exchange(m_slots, Storage(slots));
+        if constexpr (kInlineTag) {
+            m_slots.reset_tags(Metadata::kEmpty);
+        }
+        const size_t old_capacity = std::exchange(m_capacity, slots);
+        m_filter = Prefilter(slots * Sizing::den / Sizing::num);
+        m_count = 0;
+        for (size_t i = 0; i < old_capacity; ++i) {
+            int8_t old_tag;
+            if constexpr (kInlineTag) {
+                old_tag = old_slots.tag(i);
+            } else {
+                old_tag = old_ctrl[i];
+            }
+            if (old_tag != Metadata::kEmpty) {
+                insert_unique(std::move(old_slots.key(i)),
+                              std::move(old_slots.value(i)));
+            }
+        }
+    }
+
+    // Called when insert finds no slot. Only a moved-from table has none to
+    // begin with; it gets the minimal table back. Anything else is full.
+    void grow_from_empty_or_throw() {
+        if (m_capacity != 0) {
+            throw std::runtime_error("HashMap is full\n");
+        }
+        rehash(slots_for(0));
+    }
+
+    // Slot holding key, or m_capacity if it is absent.
+    size_t find_index(const K &key, size_t key_hash) const {
+        if (!m_filter.may_contain(key_hash)) {
+            return m_capacity;
+        }
+        if constexpr (kInlineTag) {
+            const size_t index = probe_slots(key, key_hash);
+            return index != m_capacity && is_full(index) ? index : m_capacity;
+        }
+        const int8_t tag = Metadata::tag(key_hash);
+        const size_t mask = m_capacity - 1;
+        Probe probe(key_hash, mask);
+
+        for (size_t n = 0; n < m_capacity / kGroupWidth; ++n) {
+            const int8_t *group = &m_ctrl[probe.pos];
+            const uint32_t empties = Match::match(group, Metadata::kEmpty);
+            uint32_t matches = candidates(Match::match(group, tag), empties);
+            while (matches != 0) {
+                const size_t index =
+                    (probe.pos + __builtin_ctz(matches)) & mask;
+                if (KeyTraits<K>::equal(m_slots.key(index), key)) {
+                    return index;
+                }
+                matches &= matches - 1;
+            }
+            if (empties != 0) {
+                return m_capacity;
+            }
+            probe.next(mask);
+        }
+        return m_capacity;
+    }
+
+  public:
+    explicit HashTable(size_t capacity)
+        : m_capacity(slots_for(capacity)), m_count(0),
+          m_ctrl(ctrl_bytes(m_capacity), Metadata::kEmpty),
+          m_slots(m_capacity), m_filter(capacity) {
+        if constexpr (kInlineTag) {
+            m_slots.reset_tags(Metadata::kEmpty);
+        }
+    }
+
+    HashTable() = delete;
+    HashTable(const HashTable &) = delete;
+    HashTable &operator=(const HashTable &) = delete;
+
+    // A moved-from table has no slots and size() 0: lookups miss, and the
+    // first insert gives it a minimal table again, like LLHashMap.
+    HashTable(HashTable &&other) noexcept
+        : m_capacity(std::exchange(other.m_capacity, 0)),
+          m_count(std::exchange(other.m_count, 0)),
+          m_ctrl(std::move(other.m_ctrl)), m_slots(std::move(other.m_slots)),
+          m_filter(std::move(other.m_filter)) {}
+
+    HashTable &operator=(HashTable &&other) noexcept {
+        HashTable moved(std::move(other));
+        swap(moved);
+        return *this;
+    }
+
+    void swap(HashTable &other) noexcept {
+        std::swap(m_capacity, other.m_capacity);
+        std::swap(m_count, other.m_count);
+        std::swap(m_ctrl, other.m_ctrl);
+        std::swap(m_slots, other.m_slots);
+        std::swap(m_filter, other.m_filter);
+    }
+
+    // Empties the table in O(capacity / 16) while keeping its storage. Only
+    // the control bytes are reset, with a memset the compiler turns into wide
+    // vector stores (InlineTag has to visit every entry instead). Old keys
+    // and values stay in their slots and are assigned over on reuse, so
+    // std::string keys keep their buffers.
+    void clear() {
+        if constexpr (kInlineTag) {
+            m_slots.reset_tags(Metadata::kEmpty);
+        } else {
+            std::memset(m_ctrl.data(), Metadata::kEmpty, m_ctrl.size());
+        }
+        m_filter.clear();
+        m_count = 0;
+    }
+
+    // Grows the table, if needed, so n entries fit at its sizing ratio.
+    void reserve(size_t n) {
+        const size_t slots = slots_for(n);
+        if (slots > m_capacity) {
+            rehash(slots);
+        }
+    }
+
+    // The hash find() and insert() would compute for key. Callers working in
+    // batches hash everything up front, prefetch, and then use the overloads
+    // below that take the hash. Those overloads require key_hash == hash(key):
+    // reserve() and the prefilter recompute hashes with hash(), so an entry
+    // stored under any other hash could no longer be found after a rehash.
+    // Pick the Hash policy instead of passing a different hash.
+    size_t hash(const K &key) const { return Hash::hash(key); }
+
+    // Pulls the first control group and slot for this hash into cache.
+    void prefetch(size_t key_hash) const {
+        const size_t pos = key_hash & (m_capacity - 1);
+        if constexpr (!kInlineTag) {
+            __builtin_prefetch(&m_ctrl[pos]);
+        }
+        m_slots.prefetch(pos);
+    }
+
+    void insert(const K &key, V value) {
+        insert(key, hash(key), std::move(value));
+    }
+
+    void insert(const K &key, size_t key_hash, V value) {
+        const int8_t tag = Metadata::tag(key_hash);
+        if constexpr (kInlineTag) {
+            const size_t index = probe_slots(key, key_hash);
+            if (index == m_capacity) {
+                grow_from_empty_or_throw();
+                insert(key, key_hash, std::move(value));
+                return;
+            }
+            if (!is_full(index)) {
+                set_ctrl(index, tag);
+                m_slots.key(index) = key;
+                m_filter.add(key_hash);
+                m_count++;
+            }
+            m_slots.value(index) = std::move(value);
+            return;
+        }
+        const size_t mask = m_capacity - 1;
+        Probe probe(key_hash, mask);
+
+        for (size_t n = 0; n < m_capacity / kGroupWidth; ++n) {
+            const int8_t *group = &m_ctrl[probe.pos];
+            const uint32_t empties = Match::match(group, Metadata::kEmpty);
+            uint32_t matches = candidates(Match::match(group, tag), empties);
+            while (matches != 0) {
+                const size_t index =
+                    (probe.pos + __builtin_ctz(matches)) & mask;
+                if (KeyTraits<K>::equal(m_slots.key(index), key)) {
+                    m_slots.value(index) = std::move(value);
+                    return;
+                }
+                matches &= matches - 1;
+            }
+            if (empties != 0) {
+                const size_t index =
+                    (probe.pos + __builtin_ctz(empties)) & mask;
+                set_ctrl(index, tag);
+                m_slots.key(index) = key;
+                m_slots.value(index) = std::move(value);
+                m_filter.add(key_hash);
+                m_count++;
+                return;
+            }
+            probe.next(mask);
+        }
+
+        grow_from_empty_or_throw();
+        insert(key, key_hash, std::move(value));
+    }
+
+    V *find(const K &key) { return find(key, hash(key)); }
+    const V *find(const K &key) const { return find(key, hash(key)); }
+
+    V *find(const K &key, size_t key_hash) {
+        const size_t index = find_index(key, key_hash);
+        return index == m_capacity ? nullptr : &m_slots.value(index);
+    }
+    const V *find(const K &key, size_t key_hash) const {
+        const size_t index = find_index(key, key_hash);
+        return index == m_capacity ? nullptr : &m_slots.value(index);
+    }
+
+    // Older name for find(), kept for the LinProbe/FPProbe/SoAProbe callers.
+    V *get_value(const K &key) { return find(key); }
+    const V *get_value(const K &key) const { return find(key); }
+
+    size_t size() const { return m_count; }
+
+    // Bytes held by the table: itself, the control and slot arrays, the
+    // prefilter, and heap bytes owned by keys. Empty slots are counted too,
+    // since a default key still takes its slot and a cleared one may still
+    // hold a buffer.
+    size_t memory_usage() const {
+        size_t bytes =
+            sizeof(*this) + m_ctrl.capacity() + m_slots.memory_usage() +
+            m_filter.memory_usage();
+        for (size_t i = 0; i < m_capacity; ++i) {
+            bytes += KeyTraits<K>::heap_bytes(m_slots.key(i));
+        }
+        return bytes;
+    }
+
+    using iterator = SlotIterator<HashTable, K, V>;
+    using const_iterator = SlotIterator<const HashTable, K, const V>;
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, m_capacity); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, m_capacity); }
+
+    // Calls fn(key, value) for every full slot, in slot order. Groups with no
+    // full slots cost one group match (one tag check per slot for InlineTag).
+    template <typename F> void for_each(F &&fn) const {
+        if constexpr (kInlineTag) {
+            for (size_t index = 0; index < m_capacity; ++index) {
+                if (is_full(index)) {
+                    fn(m_slots.key(index), m_slots.value(index));
+                }
+            }
+            return;
+        }
+        for (size_t base = 0; base < m_capacity; base += kGroupWidth) {
+            uint32_t mask = full_mask(base);
+            while (mask != 0) {
+                const size_t index = base + __builtin_ctz(mask);
+                fn(m_slots.key(index), m_slots.value(index));
+                mask &= mask - 1;
+            }
+        }
+    }
+
+    // Slot-level accessors used by SlotIterator.
+    size_t slot_count() const { return m_capacity; }
+    size_t next_occupied(size_t index) const {
+        if constexpr (kInlineTag) {
+            while (index < m_capacity && !is_full(index)) {
+                index += 1;
+            }
+            return index;
+        }
+        while (index < m_capacity) {
+            uint32_t mask = full_mask(index);
+            // Don't report mirrored bytes past the end a second time.
+            if (m_capacity - index < kGroupWidth) {
+                mask &= (1u << (m_capacity - index)) - 1;
+            }
+            if (mask != 0) {
+                return index + __builtin_ctz(mask);
+            }
+            index += kGroupWidth;
+        }
+        return m_capacity;
+    }
+    const K &key_at(size_t index) const { return m_slots.key(index); }
+    V &value_at(size_t index) { return m_slots.value(index); }
+    const V &value_at(size_t index) const { return m_slots.value(index); }
+};
+
+#endif // HASHTABLE_HPP
@@ -0,0 +1,146 @@
+#ifndef INTERNER_HPP
+#define INTERNER_HPP
+
+#include "hashtable.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+// Maps each distinct string to a dense uint32_t id (0, 1, 2, ... in first-seen
+// order) and back. Strings are copied once into an arena, and both the table
+// keys and the id -> string lookup are views into it, so ids can index plain
+// std::vectors of per-key state instead of hashing into a map again.
+class Interner {
+    // Bump allocator for key bytes. Blocks never move, so views stay valid
+    // for the lifetime of the interner.
+    class Arena {
+        static constexpr size_t kBlockSize = 64 * 1024;
+
+        std::vector<std::unique_ptr<char[]>> m_blocks;
+        char *m_cursor = nullptr;
+        size_t m_remaining = 0;
+        size_t m_bytes = 0;
+
+      public:
+        size_t memory_usage() const { return m_bytes; }
+
+        std::string_view copy(std::string_view bytes) {
+            if (bytes.size() > m_remaining) {
+                // Oversized strings get a block of their own so the current
+                // block keeps its remaining space.
+                if (bytes.size() > kBlockSize / 4) {
+                    m_blocks.emplace_back(new char[bytes.size()]);
+                    m_bytes += bytes.size();
+                    std::memcpy(m_blocks.back().get(), bytes.data(),
+                                bytes.size());
+                    return {m_blocks.back().get(), bytes.size()};
+                }
+                m_blocks.emplace_back(new char[kBlockSize]);
+                m_bytes += kBlockSize;
+                m_cursor = m_blocks.back().get();
+                m_remaining = kBlockSize;
+            }
+            char *out = m_cursor;
+            std::memcpy(out, bytes.data(), bytes.size());
+            m_cursor += bytes.size();
+            m_remaining -= bytes.size();
+            return {out, bytes.size()};
+        }
+    };
+
+    // SwissHashMap's layout with xxhash64: city names often share their
+    // first and last four bytes, which is all hash_key_fast looks at.
+    using Table = HashTable<std::string_view, uint32_t, AoS, H2Metadata,
+                            QuadraticProbe, Sse2Match, StrongHash>;
+
+    static constexpr size_t kBatchSize = 16;
+
+    Table m_table;
+    size_t m_table_capacity;
+    std::vector<std::string_view> m_strings;
+    Arena m_arena;
+
+    // Once the table holds as many keys as it was sized for, double it.
+    void grow_if_full() {
+        if (m_strings.size() < m_table_capacity) {
+            return;
+        }
+        m_table_capacity *= 2;
+        m_table.reserve(m_table_capacity);
+    }
+
+    uint32_t intern_hashed(std::string_view key, size_t key_hash) {
+        if (uint32_t *id = m_table.find(key, key_hash)) {
+            return *id;
+        }
+        // Ids are 32 bits; past 2^32 keys they would start repeating.
+        if (m_strings.size() > std::numeric_limits<uint32_t>::max()) {
+            throw std::runtime_error("Interner is full\n");
+        }
+        const uint32_t id = static_cast<uint32_t>(m_strings.size());
+        std::string_view stored = m_arena.copy(key);
+        m_strings.push_back(stored);
+        m_table.insert(stored, key_hash, id);
+        return id;
+    }
+
+  public:
+    explicit Interner(size_t capacity)
+        : m_table(capacity),
+          m_table_capacity(std::max<size_t>(capacity, 1)) {
+        m_strings.reserve(capacity);
+    }
+
+    Interner() = delete;
+    Interner(const Interner &) = delete;
+    Interner &operator=(const Interner &) = delete;
+
+    // Returns the id for key, assigning the next free id if it is new.
+    uint32_t intern(std::string_view key) {
+        grow_if_full();
+        return intern_hashed(key, m_table.hash(key));
+    }
+
+    // Interns [first, last), writing one id per key to ids. Keys are hashed
+    // and their first probe group prefetched kBatchSize at a time, so the
+    // cache misses of a batch overlap instead of being paid one by one.
+    template <typename It> void intern(It first, It last, uint32_t *ids) {
+        size_t hashes[kBatchSize];
+        while (first != last) {
+            It batch_start = first;
+            size_t n = 0;
+            for (; n < kBatchSize && first != last; ++n, ++first) {
+                hashes[n] = m_table.hash(std::string_view(*first));
+                m_table.prefetch(hashes[n]);
+            }
+            for (size_t i = 0; i < n; ++i, ++batch_start) {
+                grow_if_full();
+                *ids++ = intern_hashed(std::string_view(*batch_start),
+                                       hashes[i]);
+            }
+        }
+    }
+
+    // Id of key if it has been interned, nullptr otherwise.
+    const uint32_t *find(std::string_view key) const {
+        return m_table.find(key);
+    }
+
+    std::string_view lookup(uint32_t id) const { return m_strings[id]; }
+
+    size_t size() const { return m_strings.size(); }
+
+    // Table, id list and arena bytes.
+    size_t memory_usage() const {
+        return sizeof(*this) - sizeof(Table) + m_table.memory_usage() +
+               m_strings.capacity() * sizeof(std::string_view) +
+               m_arena.memory_usage();
+    }
+};
+
+#endif // INTERNER_HPP
@@ -0,0 +1,235 @@
+#ifndef REPORT_HPP
+#define REPORT_HPP
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Per-city aggregate for the 1BRC workload. Measurements have exactly one
+// decimal digit, so everything is kept as integer tenths and only turned
+// into text when the report is written.
+struct CityStats {
+    int32_t min = INT32_MAX;
+    int32_t max = INT32_MIN;
+    int64_t sum = 0;
+    uint64_t count = 0;
+
+    void add(int32_t tenths) {
+        min = std::min(min, tenths);
+        max = std::max(max, tenths);
+        sum += tenths;
+        count += 1;
+    }
+
+    void merge(const CityStats &other) {
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+        sum += other.sum;
+        count += other.count;
+    }
+
+    // Mean in tenths, rounded half up like the reference implementation:
+    // floor(sum / count + 1/2) = floor((2 * sum + count) / (2 * count)),
+    // with the integer division adjusted to round toward minus infinity.
+    int64_t mean() const {
+        const int64_t n = 2 * sum + static_cast<int64_t>(count);
+        const int64_t d = 2 * static_cast<int64_t>(count);
+        const int64_t q = n / d;
+        return q - (n % d != 0 && n < 0);
+    }
+};
+
+namespace detail {
+    // "00" through "99", so whole numbers are written two digits per step.
+    constexpr char kDigitPairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233"
+        "34353637383940414243444546474849505152535455565758596061626364656667"
+        "6869707172737475767778798081828384858687888990919293949596979899";
+
+    // Writes tenths as "[-]whole.frac" and returns the new end of the buffer.
+    // Measurements are almost always under 100.0, which takes one divide by
+    // a constant; larger values fall back to a loop over digit pairs.
+    inline char *write_tenths(char *out, int64_t tenths) {
+        uint64_t value = static_cast<uint64_t>(tenths);
+        if (tenths < 0) {
+            *out++ = '-';
+            value = 0 - value;
+        }
+        uint64_t whole = value / 10;
+        const char frac = static_cast<char>('0' + (value - whole * 10));
+        if (whole < 10) {
+            *out++ = static_cast<char>('0' + whole);
+        } else if (whole < 100) {
+            std::memcpy(out, &kDigitPairs[2 * whole], 2);
+            out += 2;
+        } else {
+            char digits[20];
+            char *end = digits + sizeof(digits);
+            char *begin = end;
+            while (whole >= 100) {
+                begin -= 2;
+                std::memcpy(begin, &kDigitPairs[2 * (whole % 100)], 2);
+                whole /= 100;
+            }
+            if (whole >= 10) {
+                begin -= 2;
+                std::memcpy(begin, &kDigitPairs[2 * whole], 2);
+            } else {
+                *--begin = static_cast<char>('0' + whole);
+            }
+            std::memcpy(out, begin, end - begin);
+            out += end - begin;
+        }
+        *out++ = '.';
+        *out++ = frac;
+        return out;
+    }
+} // namespace detail
+
+namespace detail {
+    // First four bytes of key, zero padded, loaded big-endian so that an
+    // integer compare agrees with the byte order of std::string_view.
+    inline uint32_t sort_prefix(std::string_view key) {
+        uint32_t prefix = 0;
+        std::memcpy(&prefix, key.data(), std::min<size_t>(key.size(), 4));
+        return __builtin_bswap32(prefix);
+    }
+
+    struct ReportEntry {
+        std::string_view key;
+        const CityStats *stats;
+    };
+
+    // What actually gets sorted: 8 bytes per entry, so each radix pass
+    // moves as little memory as possible.
+    struct ReportRow {
+        uint32_t prefix;
+        uint32_t index;
+    };
+
+    // LSD radix sort on the prefix in three 11-bit passes, whose counters
+    // fit in L1 and are all filled by one read of the rows. Passes where
+    // every row shares the digit are skipped. Rows whose prefixes tie end up
+    // adjacent and are then ordered by their full key; with four bytes of
+    // prefix those runs are short.
+    inline void sort_rows(std::vector<ReportRow> &rows,
+                          const std::vector<ReportEntry> &entries) {
+        constexpr int kBits = 11;
+        constexpr int kPasses = 3;
+        constexpr uint32_t kMask = (1u << kBits) - 1;
+        if (rows.empty()) {
+            return;
+        }
+        std::vector<uint32_t> offsets(kPasses << kBits, 0);
+        for (const ReportRow &row : rows) {
+            for (int pass = 0; pass < kPasses; ++pass) {
+                offsets[(pass << kBits) +
+                        ((row.prefix >> (pass * kBits)) & kMask)] += 1;
+            }
+        }
+        std::vector<ReportRow> scratch(rows.size());
+        for (int pass = 0; pass < kPasses; ++pass) {
+            const int shift = pass * kBits;
+            uint32_t *offset = &offsets[pass << kBits];
+            if (offset[(rows[0].prefix >> shift) & kMask] == rows.size()) {
+                continue;
+            }
+            uint32_t total = 0;
+            for (uint32_t digit = 0; digit <= kMask; ++digit) {
+                const uint32_t count = offset[digit];
+                offset[digit] = total;
+                total += count;
+            }
+            for (const ReportRow &row : rows) {
+                scratch[offset[(row.prefix >> shift) & kMask]++] = row;
+            }
+            rows.swap(scratch);
+        }
+
+        for (size_t start = 0; start < rows.size();) {
+            size_t stop = start + 1;
+            while (stop < rows.size() &&
+                   rows[stop].prefix == rows[start].prefix) {
+                stop += 1;
+            }
+            if (stop - start > 1) {
+                std::sort(rows.begin() + start, rows.begin() + stop,
+                          [&](const ReportRow &a, const ReportRow &b) {
+                              return entries[a.index].key <
+                                     entries[b.index].key;
+                          });
+            }
+            start = stop;
+        }
+    }
+} // namespace detail
+
+namespace detail {
+    // Renders "{city=min/mean/max, ...}" with cities in byte order into
+    // `buffer` and returns its length. Keys are sorted as views into the map,
+    // so no key is copied. The buffer is sized for the longest possible
+    // report but left uninitialised, so only the bytes written are touched.
+    template <typename Map>
+    size_t render_report(const Map &map, std::unique_ptr<char[]> &buffer) {
+        std::vector<ReportEntry> entries(map.size());
+        std::vector<ReportRow> rows(map.size());
+        uint32_t count = 0;
+        size_t key_bytes = 0;
+        map.for_each([&](const auto &key, const CityStats &stats) {
+            const std::string_view view(key.data(), key.size());
+            entries[count] = {view, &stats};
+            rows[count] = {sort_prefix(view), count};
+            count += 1;
+            key_bytes += key.size();
+        });
+        sort_rows(rows, entries);
+
+        // Three numbers of at most 22 chars each, plus "=", "/", "/", ", ";
+        // then the braces and room for write_report's newline.
+        constexpr size_t kMaxRowOverhead = 3 * 22 + 5;
+        buffer.reset(new char[3 + key_bytes + rows.size() * kMaxRowOverhead]);
+        char *p = buffer.get();
+        *p++ = '{';
+        for (size_t i = 0; i < rows.size(); ++i) {
+            if (i != 0) {
+                *p++ = ',';
+                *p++ = ' ';
+            }
+            const ReportEntry &entry = entries[rows[i].index];
+            std::memcpy(p, entry.key.data(), entry.key.size());
+            p += entry.key.size();
+            *p++ = '=';
+            p = write_tenths(p, entry.stats->min);
+            *p++ = '/';
+            p = write_tenths(p, entry.stats->mean());
+            *p++ = '/';
+            p = write_tenths(p, entry.stats->max);
+        }
+        *p++ = '}';
+        return p - buffer.get();
+    }
+} // namespace detail
+
+// Formats "{city=min/mean/max, ...}" with cities in byte order.
+template <typename Map> std::string format_report(const Map &map) {
+    std::unique_ptr<char[]> buffer;
+    const size_t length = detail::render_report(map, buffer);
+    return std::string(buffer.get(), length);
+}
+
+// Formats the report and emits it, newline included, with a single write
+// straight from the render buffer.
+template <typename Map> void write_report(const Map &map, std::FILE *out) {
+    std::unique_ptr<char[]> buffer;
+    size_t length = detail::render_report(map, buffer);
+    buffer[length++] = '\n';
+    std::fwrite(buffer.get(), 1, length, out);
+}
+
+#endif // REPORT_HPP
@@ -4,9 +4,13 @@
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <iterator>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 
-inline size_t hash_key_fast(const std::string &city) {
+inline size_t hash_key_fast(std::string_view city) {
     size_t len = city.size();
     size_t h = len;
     if (len >= 4) {
@@ -24,6 +28,167 @@ inline size_t hash_key_fast(const std::string &city) {
     return h;
 }
 
+// --- High-Quality Hash Function: xxHash64 ---
+namespace detail {
+    constexpr uint64_t XXH_PRIME64_1 = 0x9E3779B185EBCA87ULL;
+    constexpr uint64_t XXH_PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+    constexpr uint64_t XXH_PRIME64_3 = 0x165667B19E3779F9ULL;
+    constexpr uint64_t XXH_PRIME64_4 = 0x85EBCA77C2b2AE63ULL;
+    constexpr uint64_t XXH_PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+    inline uint64_t xxh64_round(uint64_t acc, uint64_t input) {
+        acc += input * XXH_PRIME64_2;
+        acc = (acc << 31) | (acc >> (64 - 31)); // rotl
+        acc *= XXH_PRIME64_1;
+        return acc;
+    }
+
+    inline uint64_t xxh64_avalanche(uint64_t h) {
+        h ^= h >> 33;
+        h *= XXH_PRIME64_2;
+        h ^= h >> 29;
+        h *= XXH_PRIME64_3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    inline size_t xxhash64(const void* data, size_t len, uint64_t seed = 0) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        const uint8_t* const end = p + len;
+        uint64_t h64;
+
+        if (len >= 32) {
+            const uint8_t* const limit = end - 32;
+            uint64_t v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+            uint64_t v2 = seed + XXH_PRIME64_2;
+            uint64_t v3 = seed + 0;
+            uint64_t v4 = seed - XXH_PRIME64_1;
+            do {
+                uint64_t val;
+                std::memcpy(&val, p, sizeof(val));
+                v1 = xxh64_round(v1, val);
+                p += 8;
+                std::memcpy(&val, p, sizeof(val));
+                v2 = xxh64_round(v2, val);
+                p += 8;
+                std::memcpy(&val, p, sizeof(val));
+                v3 = xxh64_round(v3, val);
+                p += 8;
+                std::memcpy(&val, p, sizeof(val));
+                v4 = xxh64_round(v4, val);
+                p += 8;
+            } while (p <= limit);
+            h64 = ((v1 << 1) | (v1 >> 63)) + ((v2 << 7) | (v2 >> 57)) + ((v3 << 12) | (v3 >> 52)) + ((v4 << 18) | (v4 >> 46));
+            h64 = xxh64_round(h64, v1);
+            h64 = xxh64_round(h64, v2);
+            h64 = xxh64_round(h64, v3);
+            h64 = xxh64_round(h64, v4);
+        } else {
+            h64 = seed + XXH_PRIME64_5;
+        }
+
+        h64 += len;
+        while (p + 8 <= end) {
+            uint64_t val;
+            std::memcpy(&val, p, sizeof(val));
+            h64 = xxh64_round(h64, val);
+            p += 8;
+        }
+        if (p + 4 <= end) {
+            uint32_t val;
+            std::memcpy(&val, p, sizeof(val));
+            h64 ^= static_cast<uint64_t>(val) * XXH_PRIME64_1;
+            h64 = ((h64 << 23) | (h64 >> 41)) * XXH_PRIME64_2 + XXH_PRIME64_3;
+            p += 4;
+        }
+        while (p < end) {
+            h64 ^= (*p) * XXH_PRIME64_5;
+            h64 = ((h64 << 11) | (h64 >> 53)) * XXH_PRIME64_1;
+            p++;
+        }
+        return xxh64_avalanche(h64);
+    }
+} // namespace detail
+
+// Integer mixer for fixed-size keys: the murmur3 64-bit finalizer
+// (multiply-xorshift). Two multiplies spread every input bit over both the
+// low bits (used for fingerprints and masks) and the high bits.
+inline uint64_t mix_u64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// Contiguous character sequences: data() must yield characters, so fixed-size
+// containers such as std::array<uint32_t, 4> are not mistaken for strings.
+template <typename K, typename = void>
+struct is_string_like : std::false_type {};
+template <typename K>
+struct is_string_like<
+    K, std::enable_if_t<
+           std::is_convertible_v<decltype(std::declval<const K &>().data()),
+                                 const char *>,
+           std::void_t<decltype(std::declval<const K &>().size())>>>
+    : std::true_type {};
+
+// Keys whose bytes are their value: integers, enums, pointers and padding-free
+// structs of those. They hash from their bytes and compare with memcmp, which
+// compiles to a plain integer compare for sizes up to 8.
+template <typename K>
+constexpr bool is_fixed_size_key_v =
+    !is_string_like<K>::value && std::has_unique_object_representations_v<K>;
+
+// How a map hashes and compares its keys. hash_fast is the cheap hash used by
+// most maps; hash_strong is the better-mixed one used by SoAProbeHashMap.
+// The primary template handles string-like keys (char data() and size()).
+template <typename K, typename = void> struct KeyTraits {
+    static_assert(is_string_like<K>::value,
+                  "keys must be string-like or fixed-size (see "
+                  "is_fixed_size_key_v)");
+
+    static size_t hash_fast(const K &key) {
+        return hash_key_fast(std::string_view(key.data(), key.size()));
+    }
+    static size_t hash_strong(const K &key) {
+        return detail::xxhash64(key.data(), key.size());
+    }
+    static bool equal(const K &a, const K &b) { return a == b; }
+
+    // Heap bytes owned by the key beyond its own object: the buffer of a
+    // std::string too long for the small-string optimisation. Views own
+    // nothing.
+    static size_t heap_bytes(const K &key) {
+        if constexpr (std::is_same_v<K, std::string>) {
+            return key.capacity() > std::string().capacity()
+                       ? key.capacity() + 1
+                       : 0;
+        } else {
+            return 0;
+        }
+    }
+};
+
+template <typename K>
+struct KeyTraits<K, std::enable_if_t<is_fixed_size_key_v<K>>> {
+    static size_t hash_fast(const K &key) {
+        if constexpr (sizeof(K) <= sizeof(uint64_t)) {
+            uint64_t bits = 0;
+            std::memcpy(&bits, &key, sizeof(K));
+            return mix_u64(bits);
+        } else {
+            return detail::xxhash64(&key, sizeof(K));
+        }
+    }
+    static size_t hash_strong(const K &key) { return hash_fast(key); }
+    static bool equal(const K &a, const K &b) {
+        return std::memcmp(&a, &b, sizeof(K)) == 0;
+    }
+    static size_t heap_bytes(const K &) { return 0; }
+};
+
 inline size_t next_power_of_2(size_t num) {
     num -= 1;
     num |= (num >> 1);
@@ -36,4 +201,50 @@ inline size_t next_power_of_2(size_t num) {
     return num;
 }
 
+// Forward iterator over the occupied slots of an open-addressing map. The map
+// supplies next_occupied(i), returning the first full slot at or after i (or
+// slot_count() when there is none), along with key_at(i) and value_at(i).
+// Dereferencing yields a pair of references, so structured bindings work:
+//   for (auto [key, value] : map) { ... }
+template <typename Map, typename K, typename V> class SlotIterator {
+    Map *m_map;
+    size_t m_index;
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::pair<const K, std::remove_const_t<V>>;
+    using reference = std::pair<const K &, V &>;
+    using difference_type = std::ptrdiff_t;
+
+    struct pointer {
+        reference ref;
+        reference *operator->() { return &ref; }
+    };
+
+    SlotIterator(Map *map, size_t index)
+        : m_map(map), m_index(map->next_occupied(index)) {}
+
+    reference operator*() const {
+        return {m_map->key_at(m_index), m_map->value_at(m_index)};
+    }
+    pointer operator->() const { return {**this}; }
+
+    SlotIterator &operator++() {
+        m_index = m_map->next_occupied(m_index + 1);
+        return *this;
+    }
+    SlotIterator operator++(int) {
+        SlotIterator old = *this;
+        ++*this;
+        return old;
+    }
+
+    bool operator==(const SlotIterator &other) const {
+        return m_index == other.m_index;
+    }
+    bool operator!=(const SlotIterator &other) const {
+        return m_index != other.m_index;
+    }
+};
+
 #endif
\ No newline at end of file
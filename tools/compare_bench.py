@@ -0,0 +1,214 @@
+#!/usr/bin/env python3
+"""Compare two JSON runs of the bench binary and flag regressions.
+
+    ./bench 1000000 --benchmark_repetitions=10 --benchmark_out=base.json
+    ./bench 1000000 --benchmark_repetitions=10 --benchmark_out=new.json
+    tools/compare_bench.py base.json new.json --threshold 5
+
+For every benchmark present in both runs, the individual repetitions are
+summarised by their median and median absolute deviation (MAD). Medians are
+compared, and a two-sided Mann-Whitney U test decides whether the samples
+differ at all. The test uses the exact U distribution for small samples
+without ties and the normal approximation otherwise. A benchmark is a
+regression when the contender's median is more than --threshold percent
+worse *and* the difference is significant at --alpha. Counters named with
+--counter (e.g. bytes_per_entry) are compared the same way, with larger
+values treated as worse.
+
+With fewer than four repetitions per side, not even completely separated
+samples reach p < 0.05, so no test is run. Such rows are judged on the
+threshold alone, marked "untested", and only fail the gate with --strict.
+
+Exits with status 1 if anything regressed, so it can gate a build. Only the
+Python standard library is used.
+"""
+
+import argparse
+import json
+import math
+import statistics
+import sys
+
+TIME_SCALE_NS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+MIN_SAMPLES = 4
+# Largest n1 * n2 for which the exact U distribution is computed.
+EXACT_MAX_CELLS = 400
+
+
+def load_samples(path, metric, counters):
+    """Returns ({run_name: {field: [values]}}, context) for a JSON run."""
+    with open(path) as f:
+        data = json.load(f)
+    runs = {}
+    for bench in data.get("benchmarks", []):
+        if bench.get("run_type", "iteration") != "iteration":
+            continue
+        fields = runs.setdefault(bench["run_name"], {})
+        scale = TIME_SCALE_NS[bench.get("time_unit", "ns")]
+        fields.setdefault(metric, []).append(bench[metric] * scale)
+        for counter in counters:
+            if counter in bench:
+                fields.setdefault(counter, []).append(float(bench[counter]))
+    return runs, data.get("context", {})
+
+
+def mad(values):
+    center = statistics.median(values)
+    return statistics.median(abs(v - center) for v in values)
+
+
+def exact_u_p(u, n1, n2):
+    """Two-sided p-value of U under the exact null distribution (no ties).
+
+    counts[n][k] holds, for the current number of first-sample values m,
+    how many orderings of m + n values give U = k; adding a first-sample
+    value that ranks above all n second-sample values adds n to U."""
+    max_u = n1 * n2
+    counts = [[1] + [0] * max_u for _ in range(n2 + 1)]
+    for _ in range(n1):
+        new = [[0] * (max_u + 1) for _ in range(n2 + 1)]
+        for n in range(n2 + 1):
+            for k in range(max_u + 1):
+                total = 0
+                if k >= n:
+                    total += counts[n][k - n]
+                if n > 0:
+                    total += new[n - 1][k]
+                new[n][k] = total
+        counts = new
+    dist = counts[n2]
+    total = sum(dist)
+    low = min(u, max_u - u)
+    tail = sum(dist[k] for k in range(int(math.floor(low)) + 1))
+    return min(1.0, 2 * tail / total)
+
+
+def mann_whitney_p(a, b):
+    """Two-sided p-value of the Mann-Whitney U test, or None if there are
+    too few samples for it to mean anything. Small samples without ties use
+    the exact distribution; the rest the normal approximation with tie and
+    continuity corrections."""
+    n1, n2 = len(a), len(b)
+    if n1 < MIN_SAMPLES or n2 < MIN_SAMPLES:
+        return None
+    combined = sorted([(v, 0) for v in a] + [(v, 1) for v in b])
+    ranks = [0.0] * len(combined)
+    tie_term = 0.0
+    i = 0
+    while i < len(combined):
+        j = i
+        while j + 1 < len(combined) and combined[j + 1][0] == combined[i][0]:
+            j += 1
+        for k in range(i, j + 1):
+            ranks[k] = (i + j) / 2 + 1
+        tied = j - i + 1
+        tie_term += tied ** 3 - tied
+        i = j + 1
+    rank_sum = sum(r for r, (_, side) in zip(ranks, combined) if side == 0)
+    u = rank_sum - n1 * (n1 + 1) / 2
+    if tie_term == 0 and n1 * n2 <= EXACT_MAX_CELLS:
+        return exact_u_p(u, n1, n2)
+    n = n1 + n2
+    mean = n1 * n2 / 2
+    variance = n1 * n2 / 12 * ((n + 1) - tie_term / (n * (n - 1)))
+    if variance <= 0:
+        return 1.0
+    z = (abs(u - mean) - 0.5) / math.sqrt(variance)
+    return math.erfc(max(z, 0.0) / math.sqrt(2))
+
+
+def warn_on_context(base, contender):
+    for key in ("cpu_model", "num_cpus", "mhz_per_cpu", "dataset_rows",
+                "distinct_cities", "library_build_type", "compiler"):
+        if key in base and key in contender and base[key] != contender[key]:
+            print(f"warning: {key} differs: {base[key]} vs {contender[key]}",
+                  file=sys.stderr)
+
+
+def format_value(field, value):
+    if field.endswith("_time"):
+        for unit, scale in (("s", 1e9), ("ms", 1e6), ("us", 1e3)):
+            if value >= scale:
+                return f"{value / scale:.3f} {unit}"
+        return f"{value:.0f} ns"
+    return f"{value:.4g}"
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Compare two bench JSON runs and flag regressions.")
+    parser.add_argument("base")
+    parser.add_argument("contender")
+    parser.add_argument("--threshold", type=float, default=5.0,
+                        help="percent change treated as a regression "
+                             "(default: 5)")
+    parser.add_argument("--alpha", type=float, default=0.05,
+                        help="significance level for the U test "
+                             "(default: 0.05)")
+    parser.add_argument("--metric", choices=("cpu_time", "real_time"),
+                        default="cpu_time")
+    parser.add_argument("--counter", action="append", default=[],
+                        help="also compare this counter; larger is worse")
+    parser.add_argument("--strict", action="store_true",
+                        help="also fail on untested rows (fewer than "
+                             f"{MIN_SAMPLES} repetitions) over the threshold")
+    parser.add_argument("--filter", default="",
+                        help="only compare benchmarks whose name contains "
+                             "this string")
+    args = parser.parse_args()
+
+    fields = [args.metric] + args.counter
+    base, base_ctx = load_samples(args.base, args.metric, args.counter)
+    contender, contender_ctx = load_samples(args.contender, args.metric,
+                                            args.counter)
+    warn_on_context(base_ctx, contender_ctx)
+
+    header = (f"{'Benchmark':<44} {'Field':<16} {'Base':>12} {'New':>12} "
+              f"{'Change':>8} {'MAD b/n':>13} {'p':>7}  Verdict")
+    print(header)
+    print("-" * len(header))
+
+    regressions = 0
+    for name in sorted(set(base) & set(contender)):
+        if args.filter not in name:
+            continue
+        for field in fields:
+            a = base[name].get(field)
+            b = contender[name].get(field)
+            if not a or not b:
+                continue
+            med_a, med_b = statistics.median(a), statistics.median(b)
+            change = (med_b - med_a) / med_a * 100 if med_a else 0.0
+            mad_a = mad(a) / med_a * 100 if med_a else 0.0
+            mad_b = mad(b) / med_b * 100 if med_b else 0.0
+            p = mann_whitney_p(a, b)
+            significant = p is None or p < args.alpha
+
+            if change > args.threshold and significant:
+                if p is None and not args.strict:
+                    verdict = "slower"
+                else:
+                    verdict = "REGRESSION"
+                    regressions += 1
+            elif change < -args.threshold and significant:
+                verdict = "improved"
+            else:
+                verdict = "same"
+            if p is None:
+                verdict += " (untested)"
+
+            p_text = "-" if p is None else f"{p:.3f}"
+            print(f"{name:<44} {field:<16} {format_value(field, med_a):>12} "
+                  f"{format_value(field, med_b):>12} {change:>+7.1f}% "
+                  f"{mad_a:>5.1f}%/{mad_b:>5.1f}% {p_text:>7}  {verdict}")
+
+    only = sorted(set(base) ^ set(contender))
+    if only:
+        print(f"\nnot in both runs: {', '.join(only)}", file=sys.stderr)
+    print(f"\n{regressions} regression(s) above {args.threshold}% "
+          f"at alpha={args.alpha}")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())